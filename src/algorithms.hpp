@@ -61,6 +61,7 @@ class Algorithms {
     void selection_sort();
     void quick_sort();
     void shell_sort();
+    void show(const std::string& name, const std::vector<size_t>& array, const std::vector<size_t>& highlighted);
   private:
     void wait();
     void swap(size_t index_1, size_t index_2);
@@ -246,9 +247,21 @@ void Algorithms::shell_sort() {
     }
 }
 
+// Displays a precomputed frame, highlighting `highlighted` like compared indicies
+void Algorithms::show(const std::string& name, const std::vector<size_t>& array, const std::vector<size_t>& highlighted) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    this->reset();
+    this->name = name;
+    this->array = array;
+    this->array_size = array.size();
+    this->comparison_indicies.insert(highlighted.begin(), highlighted.end());
+}
+
 // ============================== Private Members =============================
 
 void Algorithms::wait() {
+    // Headless instances (no condition variable) run without pacing
+    if (!this->cond) return;
     std::unique_lock<std::mutex> lock(this->mtx);
     this->cond->wait(lock);
 }
@@ -0,0 +1,472 @@
+#ifndef _SRC_DISTRIBUTED_SORT_HPP_
+#define _SRC_DISTRIBUTED_SORT_HPP_
+
+#include "../src/algorithms.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+// =============================================================================
+// ================================== Defines ==================================
+// =============================================================================
+
+#define DISTRIBUTED_SORT_NAME   "Distributed Sample Sort"
+#define SHUFFLED_NAME           "Shuffled"
+#define OVERSAMPLING            4
+#define PHASE_COUNT             4
+#define VIEW_SIZE               500
+// Descriptors left for stdio and whatever else the process holds open
+#define RESERVED_FDS            16
+
+namespace atn {
+
+// =============================================================================
+// =============================== Declarations ================================
+// =============================================================================
+
+enum class Phase {
+    LOCAL_SORT = 0,
+    SAMPLING,
+    EXCHANGE,
+    MERGE
+};
+
+const char* const PHASE_NAMES[PHASE_COUNT] = {
+        "Local Sort",
+        "Sampling",
+        "Exchange",
+        "Merge"
+};
+
+// A coarse copy of the keys for the visualizer, with the shard boundaries to highlight
+struct DistributedSnapshot {
+    std::string name;
+    std::vector<size_t> array;
+    std::vector<size_t> boundaries;
+};
+
+struct DistributedResult {
+    std::vector<size_t> array;
+    // Boundaries of each worker's output range, shard i is [shards[i], shards[i + 1])
+    std::vector<size_t> shards;
+    // Nanoseconds between the barriers that end each phase, indexed by Phase
+    std::vector<uint64_t> phases;
+    uint64_t total;
+    // Only filled in when DistributedSort::record_snapshots is set
+    std::vector<DistributedSnapshot> snapshots;
+};
+
+// Sample sort across worker processes on one host. The keys live in a shared
+// mapping with three regions: the input shards, one receive region per worker
+// and the output. Each worker sorts its shard, the coordinator picks splitters
+// from samples, then every worker copies each of its buckets into the
+// destination worker's receive region (the all-to-all exchange) and finally
+// merges its own receive region into the output. The Unix domain sockets
+// between the coordinator and the workers only carry samples, splitters,
+// bucket descriptors and barriers.
+//
+// run() forks, so it must be called before the process starts any threads.
+class DistributedSort {
+  public:
+    size_t workers;
+    int seed;
+    bool record_snapshots;
+    DistributedSort(size_t workers);
+    DistributedResult run(const SortConfig& config);
+  private:
+    size_t n;
+    size_t* input;
+    size_t* exchange;
+    size_t* output;
+    std::vector<int> coordinator_fds;
+    std::vector<int> worker_fds;
+    void check_limits() const;
+    void open_sockets();
+    void close_sockets(size_t keep);
+    void worker(size_t rank, void (Algorithms::*func)());
+    void snapshot(DistributedResult& result, const std::string& name, const size_t* source,
+            const std::vector<size_t>& shards) const;
+    size_t shard_start(size_t rank) const;
+    static void check(bool ok, const char* what);
+    static void close_fd(int& fd);
+    static uint64_t timestamp();
+    static void send_vector(int fd, const std::vector<size_t>& values);
+    static std::vector<size_t> recv_vector(int fd);
+};
+
+// =============================================================================
+// ================================ Definitions ================================
+// =============================================================================
+
+// ============================== Public Members ===============================
+
+DistributedSort::DistributedSort(size_t workers)
+        : workers(std::max<size_t>(workers, 1)), seed(time(NULL)), record_snapshots(false), n(0),
+          input(nullptr), exchange(nullptr), output(nullptr) {}
+
+DistributedResult DistributedSort::run(const SortConfig& config) {
+    #ifdef DEBUG
+    std::cerr << "Starting distributed run" << std::endl;
+    #endif
+    uint64_t start = timestamp();
+    this->n = config.n;
+    this->check_limits();
+    size_t bytes = std::max<size_t>(3 * this->n * sizeof(size_t), 1);
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    check(mapping != MAP_FAILED, "mmap");
+    this->input = static_cast<size_t*>(mapping);
+    this->exchange = this->input + this->n;
+    this->output = this->exchange + this->n;
+    DistributedResult result;
+    std::vector<pid_t> pids;
+    try {
+        // Same data the visualizer sorts: a shuffled permutation of 1..n
+        std::mt19937 rng(this->seed);
+        for (size_t i = 0; i < this->n; ++i) {
+            this->input[i] = i + 1;
+        }
+        for (size_t i = this->n - 1; i != size_t(-1); --i) {
+            std::swap(this->input[i], this->input[std::uniform_int_distribution<size_t>(0, i)(rng)]);
+        }
+        std::vector<size_t> input_shards;
+        for (size_t rank = 0; rank <= this->workers; ++rank) {
+            input_shards.push_back(this->shard_start(rank));
+        }
+        this->snapshot(result, SHUFFLED_NAME, this->input, input_shards);
+        this->open_sockets();
+        for (size_t rank = 0; rank < this->workers; ++rank) {
+            pid_t pid = fork();
+            check(pid != -1, "fork");
+            if (pid == 0) {
+                int status = EXIT_SUCCESS;
+                try {
+                    this->close_sockets(rank);
+                    this->worker(rank, config.func);
+                } catch (const std::exception& e) {
+                    #ifdef DEBUG
+                    std::cerr << "Worker " << rank << ": " << e.what() << std::endl;
+                    #endif
+                    status = EXIT_FAILURE;
+                } catch (...) {
+                    status = EXIT_FAILURE;
+                }
+                _exit(status);
+            }
+            pids.push_back(pid);
+        }
+        this->close_sockets(this->workers);
+        // Sampling: every worker sends regular samples of its sorted shard
+        std::vector<size_t> samples;
+        for (int fd : this->coordinator_fds) {
+            std::vector<size_t> sample = recv_vector(fd);
+            samples.insert(samples.end(), sample.begin(), sample.end());
+        }
+        this->snapshot(result, PHASE_NAMES[size_t(Phase::LOCAL_SORT)], this->input, input_shards);
+        std::sort(samples.begin(), samples.end());
+        std::vector<size_t> splitters;
+        for (size_t i = 1; i < this->workers; ++i) {
+            splitters.push_back(samples.empty() ? SIZE_MAX : samples[i * samples.size() / this->workers]);
+        }
+        for (int fd : this->coordinator_fds) {
+            send_vector(fd, splitters);
+        }
+        // Exchange: lay out the receive regions from the bucket bounds. Worker
+        // i's region starts at shards[i] and holds the buckets for i in source
+        // order. Each worker gets its own region offset, where each of its
+        // buckets goes, and how many keys it receives from every source.
+        std::vector<std::vector<size_t>> bounds;
+        for (int fd : this->coordinator_fds) {
+            bounds.push_back(recv_vector(fd));
+            if (bounds.back().size() != this->workers + 1) {
+                throw std::runtime_error("Malformed bucket bounds");
+            }
+        }
+        std::vector<std::vector<size_t>> destinations(this->workers, std::vector<size_t>(this->workers, 0));
+        result.shards.push_back(0);
+        for (size_t rank = 0; rank < this->workers; ++rank) {
+            size_t offset = result.shards.back();
+            for (size_t source = 0; source < this->workers; ++source) {
+                destinations[source][rank] = offset;
+                offset += bounds[source][rank + 1] - bounds[source][rank];
+            }
+            result.shards.push_back(offset);
+        }
+        for (size_t rank = 0; rank < this->workers; ++rank) {
+            std::vector<size_t> descriptors = {result.shards[rank]};
+            descriptors.insert(descriptors.end(), destinations[rank].begin(), destinations[rank].end());
+            for (size_t source = 0; source < this->workers; ++source) {
+                descriptors.push_back(bounds[source][rank + 1] - bounds[source][rank]);
+            }
+            send_vector(this->coordinator_fds[rank], descriptors);
+        }
+        // Every bucket must have landed before anyone merges its receive region
+        for (int fd : this->coordinator_fds) {
+            recv_vector(fd);
+        }
+        this->snapshot(result, PHASE_NAMES[size_t(Phase::EXCHANGE)], this->exchange, result.shards);
+        for (int fd : this->coordinator_fds) {
+            send_vector(fd, {});
+        }
+        // Workers report when they started and when they left each phase. A
+        // phase ends when the last worker leaves it, so each phase is measured
+        // from the previous barrier rather than including the wait for it.
+        uint64_t started = UINT64_MAX;
+        std::vector<uint64_t> barriers(PHASE_COUNT, 0);
+        for (int fd : this->coordinator_fds) {
+            std::vector<size_t> timestamps = recv_vector(fd);
+            if (timestamps.size() != PHASE_COUNT + 1) {
+                throw std::runtime_error("Malformed worker timestamps");
+            }
+            started = std::min<uint64_t>(started, timestamps[0]);
+            for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+                barriers[phase] = std::max<uint64_t>(barriers[phase], timestamps[phase + 1]);
+            }
+        }
+        for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            result.phases.push_back(barriers[phase] - (phase == 0 ? started : barriers[phase - 1]));
+        }
+        for (size_t rank = 0; rank < this->workers; ++rank) {
+            int status;
+            check(waitpid(pids[rank], &status, 0) != -1, "waitpid");
+            pids[rank] = -1;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                throw std::runtime_error("Worker " + std::to_string(rank) + " failed");
+            }
+        }
+        this->snapshot(result, PHASE_NAMES[size_t(Phase::MERGE)], this->output, result.shards);
+    } catch (...) {
+        this->close_sockets(this->workers + 1);
+        for (pid_t pid : pids) {
+            if (pid == -1) continue;
+            kill(pid, SIGKILL);
+            waitpid(pid, nullptr, 0);
+        }
+        munmap(mapping, bytes);
+        this->input = this->exchange = this->output = nullptr;
+        throw;
+    }
+    this->close_sockets(this->workers + 1);
+    result.array.assign(this->output, this->output + this->n);
+    munmap(mapping, bytes);
+    this->input = this->exchange = this->output = nullptr;
+    result.total = timestamp() - start;
+    #ifdef DEBUG
+    std::cerr << "Ending distributed run" << std::endl;
+    #endif
+    return result;
+}
+
+// ============================== Private Members =============================
+
+// The coordinator holds both ends of every worker's socketpair until it forks
+void DistributedSort::check_limits() const {
+    if (this->n > SIZE_MAX / (3 * sizeof(size_t))) {
+        throw std::runtime_error(std::to_string(this->n) + " keys do not fit in memory");
+    }
+    struct rlimit limit;
+    check(getrlimit(RLIMIT_NOFILE, &limit) == 0, "getrlimit");
+    if (limit.rlim_cur == RLIM_INFINITY) return;
+    rlim_t available = limit.rlim_cur > RESERVED_FDS ? limit.rlim_cur - RESERVED_FDS : 0;
+    if (this->workers > available / 2) {
+        throw std::runtime_error("Too many workers: RLIMIT_NOFILE of " + std::to_string(limit.rlim_cur)
+                + " allows at most " + std::to_string(available / 2));
+    }
+}
+
+void DistributedSort::open_sockets() {
+    this->coordinator_fds.assign(this->workers, -1);
+    this->worker_fds.assign(this->workers, -1);
+    for (size_t i = 0; i < this->workers; ++i) {
+        int fds[2];
+        check(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds) == 0, "socketpair");
+        this->coordinator_fds[i] = fds[0];
+        this->worker_fds[i] = fds[1];
+    }
+}
+
+// Closes every descriptor not owned by `keep`, where `keep == workers` is the
+// coordinator and anything larger closes them all
+void DistributedSort::close_sockets(size_t keep) {
+    for (size_t i = 0; i < this->coordinator_fds.size(); ++i) {
+        if (keep != this->workers) close_fd(this->coordinator_fds[i]);
+        if (i != keep) close_fd(this->worker_fds[i]);
+    }
+}
+
+void DistributedSort::worker(size_t rank, void (Algorithms::*func)()) {
+    int coordinator = this->worker_fds[rank];
+    std::vector<size_t> timestamps = {timestamp()};
+    // Local sort with one of the existing algorithms, unpaced
+    size_t start = this->shard_start(rank);
+    size_t size = this->shard_start(rank + 1) - start;
+    size_t* shard = this->input + start;
+    Algorithms algos(nullptr, size);
+    if (size > 1) {
+        algos.array.assign(shard, shard + size);
+        (algos.*func)();
+        std::copy(algos.array.begin(), algos.array.end(), shard);
+    }
+    timestamps.push_back(timestamp());
+    // Sampling
+    std::vector<size_t> sample;
+    size_t sample_size = std::min(size, this->workers * OVERSAMPLING);
+    for (size_t i = 0; i < sample_size; ++i) {
+        sample.push_back(shard[(2 * i + 1) * size / (2 * sample_size)]);
+    }
+    send_vector(coordinator, sample);
+    std::vector<size_t> splitters = recv_vector(coordinator);
+    std::vector<size_t> bounds = {0};
+    for (size_t splitter : splitters) {
+        bounds.push_back(std::upper_bound(shard + bounds.back(), shard + size, splitter) - shard);
+    }
+    bounds.resize(this->workers, size);
+    bounds.push_back(size);
+    timestamps.push_back(timestamp());
+    // Exchange: copy every bucket into its destination's receive region
+    send_vector(coordinator, bounds);
+    std::vector<size_t> descriptors = recv_vector(coordinator);
+    if (descriptors.size() != 2 * this->workers + 1) {
+        throw std::runtime_error("Malformed bucket descriptors");
+    }
+    for (size_t destination = 0; destination < this->workers; ++destination) {
+        std::copy(shard + bounds[destination], shard + bounds[destination + 1],
+                this->exchange + descriptors[1 + destination]);
+    }
+    timestamps.push_back(timestamp());
+    send_vector(coordinator, {});
+    recv_vector(coordinator);
+    // Merge the sorted runs in this worker's receive region
+    typedef std::pair<size_t, size_t> Run;
+    std::vector<Run> runs;
+    size_t offset = descriptors[0];
+    for (size_t source = 0; source < this->workers; ++source) {
+        size_t count = descriptors[1 + this->workers + source];
+        if (count != 0) runs.push_back(Run(offset, count));
+        offset += count;
+    }
+    typedef std::pair<size_t, size_t> Head;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        heads.push(Head(this->exchange[runs[i].first], i));
+    }
+    size_t* out = this->output + descriptors[0];
+    while (!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        *out++ = head.first;
+        Run& run = runs[head.second];
+        if (--run.second != 0) {
+            heads.push(Head(this->exchange[++run.first], head.second));
+        }
+    }
+    timestamps.push_back(timestamp());
+    send_vector(coordinator, timestamps);
+    close_fd(this->worker_fds[rank]);
+}
+
+// Downsamples `source` to at most VIEW_SIZE bars scaled to 1..VIEW_SIZE
+void DistributedSort::snapshot(DistributedResult& result, const std::string& name, const size_t* source,
+        const std::vector<size_t>& shards) const {
+    if (!this->record_snapshots || this->n == 0) return;
+    DistributedSnapshot snapshot;
+    snapshot.name = std::string(DISTRIBUTED_SORT_NAME) + " - " + name;
+    size_t size = std::min<size_t>(this->n, VIEW_SIZE);
+    for (size_t i = 0; i < size; ++i) {
+        snapshot.array.push_back(std::max<size_t>(source[i * this->n / size] * size / this->n, 1));
+    }
+    for (size_t i = 1; i + 1 < shards.size(); ++i) {
+        snapshot.boundaries.push_back(std::min(shards[i] * size / this->n, size - 1));
+    }
+    result.snapshots.push_back(snapshot);
+}
+
+size_t DistributedSort::shard_start(size_t rank) const {
+    return rank * this->n / this->workers;
+}
+
+void DistributedSort::check(bool ok, const char* what) {
+    if (!ok) throw std::system_error(errno, std::generic_category(), what);
+}
+
+void DistributedSort::close_fd(int& fd) {
+    if (fd != -1) close(fd);
+    fd = -1;
+}
+
+// steady_clock is CLOCK_MONOTONIC, so timestamps compare across processes on one host
+uint64_t DistributedSort::timestamp() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Each message is one SOCK_SEQPACKET record: a length header gathered with its payload
+void DistributedSort::send_vector(int fd, const std::vector<size_t>& values) {
+    size_t length = values.size();
+    struct iovec iov[2];
+    iov[0].iov_base = &length;
+    iov[0].iov_len = sizeof(length);
+    iov[1].iov_base = const_cast<size_t*>(values.data());
+    iov[1].iov_len = length * sizeof(size_t);
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sent == -1 && errno == EINTR);
+    check(sent == ssize_t(sizeof(length) + iov[1].iov_len), "sendmsg");
+}
+
+std::vector<size_t> DistributedSort::recv_vector(int fd) {
+    size_t length;
+    ssize_t peeked;
+    do {
+        peeked = recv(fd, &length, sizeof(length), MSG_PEEK);
+    } while (peeked == -1 && errno == EINTR);
+    if (peeked == 0) throw std::runtime_error("recv: peer closed connection");
+    check(peeked == ssize_t(sizeof(length)), "recv");
+    std::vector<size_t> values(length, 0);
+    struct iovec iov[2];
+    iov[0].iov_base = &length;
+    iov[0].iov_len = sizeof(length);
+    iov[1].iov_base = values.data();
+    iov[1].iov_len = length * sizeof(size_t);
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &msg, 0);
+    } while (received == -1 && errno == EINTR);
+    if (received == 0) throw std::runtime_error("recvmsg: peer closed connection");
+    check(received == ssize_t(sizeof(length) + iov[1].iov_len) && !(msg.msg_flags & MSG_TRUNC), "recvmsg");
+    return values;
+}
+
+} // End namespace atn
+
+#endif // _SRC_DISTRIBUTED_SORT_HPP_
@@ -1,14 +1,83 @@
 #include "../src/algorithms.hpp"
+#include "../src/distributed_sort.hpp"
 #include "../src/visualizer_window.hpp"
-#ifdef DEBUG
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <iostream>
-#endif
+
+#define DISTRIBUTED_FLAG      "--distributed"
+#define DISTRIBUTED_VIEW_FLAG "--distributed-view"
+#define DISTRIBUTED_WORKERS   4
+#define DISTRIBUTED_SIZE      100000
+#define DISTRIBUTED_USAGE     "Usage: run.exe --distributed|--distributed-view [workers] [n]"
+
+// Parses a positive count, rejecting signs, trailing characters and overflow
+size_t parse_count(const char* arg, const char* what) {
+    size_t length = std::strlen(arg);
+    if (length == 0 || !std::all_of(arg, arg + length, [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; })) {
+        throw std::invalid_argument(std::string(what) + " must be a positive integer: " + arg);
+    }
+    size_t count;
+    try {
+        count = std::stoul(arg);
+    } catch (const std::out_of_range&) {
+        throw std::invalid_argument(std::string(what) + " is out of range: " + arg);
+    }
+    if (count == 0) {
+        throw std::invalid_argument(std::string(what) + " must be a positive integer: " + arg);
+    }
+    return count;
+}
+
+// Runs the distributed sort and prints its phase timings. With `view`, the
+// per-phase snapshots are returned for the visualizer through `snapshots`.
+int run_distributed(int argc, char** argv, bool view, std::vector<atn::DistributedSnapshot>& snapshots) {
+    try {
+        size_t workers = argc > 2 ? parse_count(argv[2], "workers") : DISTRIBUTED_WORKERS;
+        size_t n = argc > 3 ? parse_count(argv[3], "n") : DISTRIBUTED_SIZE;
+        atn::DistributedSort sort(workers);
+        sort.record_snapshots = view;
+        atn::DistributedResult result = sort.run(atn::SortConfig{&atn::Algorithms::quick_sort, n});
+        for (size_t i = 0; i < n; ++i) {
+            if (result.array[i] != i + 1) {
+                std::cerr << "Result is not sorted at index " << i << std::endl;
+                return 1;
+            }
+        }
+        std::cout << DISTRIBUTED_SORT_NAME << ": " << sort.workers << " workers, " << n << " keys" << std::endl;
+        for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            std::cout << "  " << atn::PHASE_NAMES[phase] << ": " << result.phases[phase] / 1e6 << " ms" << std::endl;
+        }
+        std::cout << "  Total: " << result.total / 1e6 << " ms" << std::endl;
+        snapshots = result.snapshots;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl << DISTRIBUTED_USAGE << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
 int main(int argc, char** argv) {
     #ifdef DEBUG
     std::cerr << "Starting main" << std::endl;
     #endif
+    bool distributed = argc > 1 && std::strcmp(argv[1], DISTRIBUTED_FLAG) == 0;
+    bool view = argc > 1 && std::strcmp(argv[1], DISTRIBUTED_VIEW_FLAG) == 0;
+    if (distributed || view) {
+        // The workers are forked here, before GTK starts any threads
+        std::vector<atn::DistributedSnapshot> snapshots;
+        int status = run_distributed(argc, argv, view, snapshots);
+        if (status != 0 || !view) return status;
+        int gtk_argc = 1;
+        auto app = Gtk::Application::create(gtk_argc, argv, "atn.sortingvisualizer");
+        atn::VisualizerWindow window(snapshots);
+        return app->run(window);
+    }
     auto app = Gtk::Application::create(argc, argv, "atn.sortingvisualizer");
     atn::VisualizerWindow window;
     return app->run(window);
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 #define _SRC_VISUALIZER_DRAWING_AREA_HPP_
 
 #include "../src/algorithms.hpp"
+#include "../src/distributed_sort.hpp"
 
 #include <cmath>
 #include <condition_variable>
@@ -26,6 +27,7 @@ class VisualizerDrawingArea : public Gtk::DrawingArea {
     atn::Algorithms algos;
     std::thread t;
     VisualizerDrawingArea();
+    VisualizerDrawingArea(const std::vector<DistributedSnapshot>& snapshots);
     virtual ~VisualizerDrawingArea();
     void init(const int width, const int height);
   protected:
@@ -34,6 +36,7 @@ class VisualizerDrawingArea : public Gtk::DrawingArea {
     float _bar_scale;
     float _bar_width;
     bool update();
+    void replay(std::vector<DistributedSnapshot> snapshots);
     void draw_rectangle(const Cairo::RefPtr<Cairo::Context>& cr, const int width, const int height, size_t index);
     void draw_stats(const Cairo::RefPtr<Cairo::Context>& cr, const int width, const int height);
     void draw_array(const Cairo::RefPtr<Cairo::Context>& cr, const int width, const int height);
@@ -51,6 +54,19 @@ VisualizerDrawingArea::VisualizerDrawingArea(): cond(std::make_shared<std::condi
     #endif
 }
 
+// Cycles through the snapshots of a finished distributed run instead of sorting
+VisualizerDrawingArea::VisualizerDrawingArea(const std::vector<DistributedSnapshot>& snapshots)
+        : cond(std::make_shared<std::condition_variable>()), algos(cond, ARRAY_SIZE) {
+    #ifdef DEBUG
+    std::cerr << "Starting VisualizerDrawingArea constructor" << std::endl;
+    #endif
+    Glib::signal_timeout().connect(sigc::mem_fun(*this, &VisualizerDrawingArea::update), REFRESH_RATE);
+    t = std::thread(&VisualizerDrawingArea::replay, this, snapshots);
+    #ifdef DEBUG
+    std::cerr << "Ending VisualizerDrawingArea constructor" << std::endl;
+    #endif
+}
+
 VisualizerDrawingArea::~VisualizerDrawingArea() {}
 
 void VisualizerDrawingArea::init(const int width, const int height) {
@@ -72,6 +88,7 @@ bool VisualizerDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
     cr->set_source_rgb(0.0, 0.0, 0.0);
     cr->rectangle(0, 0, width, height);
     cr->fill();
+    std::lock_guard<std::mutex> lock(this->algos.mtx);
     // Init
     this->init(width, height);
     // Draw stats
@@ -102,6 +119,15 @@ bool VisualizerDrawingArea::update() {
     return true;
 }
 
+void VisualizerDrawingArea::replay(std::vector<DistributedSnapshot> snapshots) {
+    while (!snapshots.empty()) {
+        for (const DistributedSnapshot& snapshot : snapshots) {
+            this->algos.show(snapshot.name, snapshot.array, snapshot.boundaries);
+            std::this_thread::sleep_for(std::chrono::milliseconds(4 * DELAY));
+        }
+    }
+}
+
 void VisualizerDrawingArea::draw_rectangle(const Cairo::RefPtr<Cairo::Context>& cr, const int width, const int height, size_t index) {
     cr->rectangle(index * (SEPARATION + this->_bar_width), 
             height - this->algos.array[index] * this->_bar_scale,
@@ -14,6 +14,14 @@ class VisualizerWindow : public Gtk::Window {
     VisualizerDrawingArea drawing_area;
   public:
     VisualizerWindow() : drawing_area() {
+        this->setup();
+    }
+    VisualizerWindow(const std::vector<DistributedSnapshot>& snapshots) : drawing_area(snapshots) {
+        this->setup();
+    }
+    virtual ~VisualizerWindow() {}
+  private:
+    void setup() {
         #ifdef DEBUG
         std::cerr << "Starting VisualizerWindow constructor" << std::endl;
         #endif
@@ -25,7 +33,6 @@ class VisualizerWindow : public Gtk::Window {
         std::cerr << "Ending VisualizerWindow constructor" << std::endl;
         #endif
     }
-    virtual ~VisualizerWindow() {}
 };
 
 } // End namespace atn